@@ -0,0 +1,166 @@
+#! /usr/bin/env bash
+## vim:set ts=4 sw=4 et:
+set -e; set -o pipefail
+
+# Copyright (C) Markus Franz Xaver Johannes Oberhumer
+
+# Exec-to-main startup benchmark for packed amd64 Linux ELF.
+#
+# Builds synthetic test programs of several sizes (static, PIE, and
+# a PIE that loads a packed shared library), packs each one with every
+# combination of method/filter/unfilter-window, and execs it many times.
+# The test programs return from main() immediately, so the wall time
+# of one run is the time-to-main plus a (constant) exit.
+#
+# Reports percentiles of the wall time, page faults and peak RSS
+# as a table on stdout and as JSON.
+#
+# usage: bench_startup.sh path/to/upx [workdir]
+#
+# environment (all optional):
+#   CC                  C compiler (default: cc)
+#   BENCH_RUNS          execs per packed program (default: 200)
+#   BENCH_SIZES         number of generated functions per program
+#   BENCH_METHODS       upx method options
+#   BENCH_FILTERS       upx filter options ("-" is the default filter)
+#   BENCH_UNFILTER_WINDOWS  values for --unfilter-window ("-" is unlimited);
+#                       the packed shared library is run with "-" only,
+#                       because upx ignores the option for shared libraries
+#   BENCH_JSON          output file (default: workdir/bench_startup.json)
+#
+# Exits non-zero as soon as a packed program fails to run.
+
+upx="$1"
+[[ -n $upx && -x $upx ]] || { echo "usage: $0 path/to/upx [workdir]" >&2; exit 1; }
+upx="$(cd "$(dirname "$upx")" && pwd)/$(basename "$upx")"
+work="${2:-./tmp-bench-startup}"
+mkdir -p "$work"; cd "$work" || exit 1
+
+CC="${CC:-cc}"
+runs="${BENCH_RUNS:-200}"
+sizes="${BENCH_SIZES:-1000 10000 40000}"
+methods="${BENCH_METHODS:---nrv2b --nrv2d --nrv2e --lzma}"
+filters="${BENCH_FILTERS:-- --no-filter}"
+windows="${BENCH_UNFILTER_WINDOWS:-- 65536 1048576}"
+json="${BENCH_JSON:-bench_startup.json}"
+
+# fork+exec+wait4 one program 'n' times; one line per run:
+#   nanoseconds minflt majflt maxrss_kb
+cat > runner.c <<'EOF'
+#define _GNU_SOURCE 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+int main(int argc, char **argv) {
+    if (argc < 3) return 1;
+    long n = atol(argv[1]);
+    for (long j = 0; j < n; ++j) {
+        struct timespec t0, t1;
+        struct rusage ru;
+        int status = 0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        pid_t pid = fork();
+        if (pid == 0) {
+            execv(argv[2], &argv[2]);
+            _exit(127);
+        }
+        if (pid < 0 || wait4(pid, &status, 0, &ru) != pid) return 1;
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return 2;
+        printf("%lld %ld %ld %ld\n",
+               (long long) (t1.tv_sec - t0.tv_sec) * 1000000000LL + (t1.tv_nsec - t0.tv_nsec),
+               ru.ru_minflt, ru.ru_majflt, ru.ru_maxrss);
+    }
+    return 0;
+}
+EOF
+$CC -O2 -o runner runner.c
+
+# generate 'nf' non-trivial functions plus a table that keeps them alive
+gen_funcs() {
+    local nf=$1
+    awk -v nf="$nf" 'BEGIN {
+        for (i = 0; i < nf; i++) {
+            printf("unsigned f%d(unsigned x) { unsigned y = x * %du + %du;\n", i, 2*i+3, i);
+            printf("  for (int k = 0; k < (int)(x & 7); k++) y = (y << 3) ^ (y >> 5) ^ %du;\n", i*7919);
+            printf("  return y + (x > %du ? f%d(x - 1) : 0u); }\n", i, (i ? i-1 : 0));
+        }
+        printf("unsigned (*const ftab[])(unsigned) = {\n");
+        for (i = 0; i < nf; i++) printf("  f%d,\n", i);
+        printf("};\nunsigned const nftab = %d;\n", nf);
+    }'
+}
+
+main_c='extern unsigned (*const ftab[])(unsigned); extern unsigned const nftab;
+int main(int argc, char **argv) { (void) argv;
+    return argc > 1 ? (int) (ftab[argc % nftab](argc) & 1) : 0; }'
+
+programs=()
+for nf in $sizes; do
+    gen_funcs "$nf" > "funcs$nf.c"
+    echo "$main_c" > "main$nf.c"
+    if $CC -O1 -static -o "static$nf" "main$nf.c" "funcs$nf.c" 2>/dev/null; then
+        programs+=("static$nf:static$nf")
+    fi
+    $CC -O1 -fPIE -pie -o "pie$nf" "main$nf.c" "funcs$nf.c"
+    programs+=("pie$nf:pie$nf")
+    mkdir -p "shlib$nf"
+    $CC -O1 -fPIC -shared -Wl,-soname,libfuncs.so -o "shlib$nf/libfuncs.so" "funcs$nf.c"
+    $CC -O1 -fPIE -pie -o "shlib$nf/main" "main$nf.c" -L"shlib$nf" -lfuncs -Wl,-rpath,'$ORIGIN'
+    programs+=("shlib$nf/main:shlib$nf/libfuncs.so")
+done
+
+# percentile 'p' of the sorted numbers on stdin
+pct() { sort -n | awk -v p="$1" '{ a[NR] = $1 } END { i = int((NR * p + 99) / 100); if (i < 1) i = 1; print a[i] }'; }
+
+: > results.txt
+printf '%-24s %-10s %-12s %-8s %10s %10s %10s %8s %8s\n' \
+    program method filter window p50_us p90_us p99_us minflt maxrss_kb
+measure() { # name method filter window exe
+    local out=run.txt
+    if ! ./runner "$runs" "$5" > "$out"; then
+        printf '%-24s %-10s %-12s %-8s %s\n' "$1" "$2" "$3" "$4" "run failed" >&2
+        exit 1
+    fi
+    local p50 p90 p99 flt rss
+    p50=$(awk '{ print int($1 / 1000) }' "$out" | pct 50)
+    p90=$(awk '{ print int($1 / 1000) }' "$out" | pct 90)
+    p99=$(awk '{ print int($1 / 1000) }' "$out" | pct 99)
+    flt=$(awk '{ print $2 + $3 }' "$out" | pct 50)
+    rss=$(awk '{ print $4 }' "$out" | pct 50)
+    printf '%-24s %-10s %-12s %-8s %10s %10s %10s %8s %8s\n' "$1" "$2" "$3" "$4" "$p50" "$p90" "$p99" "$flt" "$rss"
+    echo "$1 $2 $3 $4 $p50 $p90 $p99 $flt $rss" >> results.txt
+}
+
+for prog in "${programs[@]}"; do
+    exe="${prog%%:*}"; target="${prog##*:}"
+    cp -p "$target" "$target.orig"
+    prog_windows="$windows"
+    [[ $target != *.so ]] || prog_windows="-"
+    measure "$exe" none - - "./$exe"
+    for m in $methods; do
+        for f in $filters; do
+            for b in $prog_windows; do
+                args=("$m")
+                [[ $f == - ]] || args+=("$f")
+                [[ $b == - ]] || args+=("--unfilter-window=$b")
+                if ! "$upx" -qqq "${args[@]}" --force-overwrite -o "$target" "$target.orig"; then
+                    printf '%-24s %-10s %-12s %-8s %s\n' "$exe" "$m" "$f" "$b" "pack failed"
+                    continue
+                fi
+                measure "$exe" "$m" "$f" "$b" "./$exe"
+            done
+        done
+    done
+    cp -p "$target.orig" "$target"
+done
+
+awk -v runs="$runs" 'BEGIN { printf("{\n  \"runs\": %d,\n  \"results\": [", runs); sep = "" }
+    { printf("%s\n    { \"program\": \"%s\", \"method\": \"%s\", \"filter\": \"%s\", \"window\": \"%s\", " \
+             "\"p50_us\": %d, \"p90_us\": %d, \"p99_us\": %d, \"faults\": %d, \"maxrss_kb\": %d }",
+             sep, $1, $2, $3, $4, $5, $6, $7, $8, $9); sep = "," }
+    END { printf("\n  ]\n}\n") }' results.txt > "$json"
+echo "JSON results written to $work/$json"
@@ -0,0 +1,47 @@
+/* gen_nearly_stored.c -- write the source of a test program for ctest
+
+   This file is part of the UPX executable compressor.
+
+   Copyright (C) Markus Franz Xaver Johannes Oberhumer
+   All Rights Reserved.
+ */
+
+/* The generated program has a read-only PT_LOAD which LZMA shrinks by
+   less than 1/128: 1 MiB of xorshift noise (about 1.4% larger when
+   compressed), followed by 18 KiB of zeros.  PackUnix::packExtent()
+   then stores that block although compress() succeeded.  The zeros go
+   last, so that the block also passes the in-place overlap test.
+   A writable text array keeps the whole file compressible. */
+
+#include <stdio.h>
+
+int main(int argc, char **argv) {
+    unsigned long long x = 0x9e3779b97f4a7c15ull;
+    unsigned i;
+    FILE *f;
+
+    if (argc != 2 || (f = fopen(argv[1], "w")) == NULL) {
+        fprintf(stderr, "usage: %s output.c\n", argv[0]);
+        return 1;
+    }
+    fprintf(f, "struct nearly_stored { unsigned char noise[1u << 20]; unsigned char zeros[18u << 10]; };\n");
+    fprintf(f, "const struct nearly_stored nearly_stored = {{\n");
+    for (i = 0; i < (1u << 20); i++) {
+        if ((i & 3) == 0) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+        }
+        fprintf(f, "%u,%s", (unsigned) (x >> (32 + 8 * (i & 3))) & 0xff, (i & 31) == 31 ? "\n" : "");
+    }
+    fprintf(f, "}, {0}};\n");
+    fprintf(f, "char text[] =\n");
+    for (i = 0; i < 4096; i++)
+        fprintf(f, "\"line %4u: the quick brown fox jumps over the lazy dog\\n\"\n", i);
+    fprintf(f, ";\n");
+    fprintf(f, "int main(int argc, char **argv) {\n"
+               "    (void) argv;\n"
+               "    return (nearly_stored.noise[argc] + nearly_stored.zeros[argc] + text[argc]) == 0x1ff;\n"
+               "}\n");
+    return fclose(f) == 0 ? 0 : 1;
+}
@@ -206,4 +206,35 @@ bool Filter::scan(const upx_byte *buf_, unsigned buf_len_) {
     return false;
 }
 
+/*************************************************************************
+//
+**************************************************************************/
+
+TEST_CASE("Filter 0x49") {
+    // CALL, JMP and 6-byte Jcc, each to a target inside the buffer
+    upx_byte buf[4096], orig[4096];
+    memset(buf, 0x90, sizeof(buf));
+    for (unsigned i = 16; i + 16 <= sizeof(buf); i += 16) {
+        unsigned const target = (i * 7) % sizeof(buf);
+        unsigned const k = (i >> 4) % 3;
+        if (k == 2) {
+            buf[i] = 0x0f;
+            buf[i + 1] = 0x84;
+            set_le32(buf + i + 2, target - (i + 6));
+        } else {
+            buf[i] = (upx_byte) (0xe8 + k);
+            set_le32(buf + i + 1, target - (i + 5));
+        }
+    }
+    memcpy(orig, buf, sizeof(buf));
+    Filter ft(10);
+    ft.init(0x49, 0);
+    CHECK(ft.filter(buf, sizeof(buf)));
+    CHECK(ft.calls == sizeof(buf) / 16 - 1);
+    CHECK(memcmp(buf, orig, sizeof(buf)) != 0);
+    ft.unfilter(buf, sizeof(buf), true);
+    CHECK(ft.calls == sizeof(buf) / 16 - 1);
+    CHECK(memcmp(buf, orig, sizeof(buf)) == 0);
+}
+
 /* vim:set ts=4 sw=4 et: */
@@ -150,20 +150,24 @@ static int U(Filter *f)
 
     unsigned ic, jc;
 
+    // Every marked displacement begins with cto8, so let memchr()
+    // (vectorized by libc) skip the runs of code which have no marker.
+    // Note: f->noncalls is not counted here.
     for (ic = 0; ic < size5; ic++)
+    {
+        const upx_byte *const p = (const upx_byte *) memchr(b+ic+1, f->cto, size5 - ic);
+        if (p == nullptr)
+            break;
+        ic = (unsigned) (p - b) - 1;
         if (COND(b,ic,lastcall,id))
         {
             jc = get_be32(b+ic+1);
-            if (b[ic+1] == f->cto)
-            {
-                set_le32(b+ic+1,jc-ic-1-addvalue-cto);
-                f->calls++;
-                ic += 4;
-                f->lastcall = lastcall = ic+1;
-            }
-            else
-                f->noncalls++;
+            set_le32(b+ic+1,jc-ic-1-addvalue-cto);
+            f->calls++;
+            ic += 4;
+            f->lastcall = lastcall = ic+1;
         }
+    }
     return 0;
 }
 #endif
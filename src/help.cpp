@@ -293,7 +293,12 @@ void show_help(int verbose)
         con_fprintf(f,"Options for linux/elf:\n");
         fg = con_fg(f,fg);
         con_fprintf(f,
+                    "  --blocksize=auto        use smaller blocks if they compress as well; only\n"
+                    "                          linux.exec (ignored for elf, linux.sh, Mach-O)\n"
                     "  --preserve-build-id     copy .gnu.note.build-id to compressed output\n"
+                    "  --unfilter-window=SIZE  filter code in blocks of at most SIZE bytes,\n"
+                    "                          so the stub unfilters each one while cache-hot\n"
+                    "                          (main programs only; ignored for shared libraries)\n"
                     "\n");
     }
 
@@ -40,6 +40,51 @@ static bool update_capacity(unsigned size, unsigned *capacity) {
     return true;
 }
 
+// FNV-1a
+static unsigned hash_name(const char *s) {
+    unsigned h = 2166136261u;
+    for (; *s; ++s)
+        h = (h ^ (unsigned char) *s) * 16777619u;
+    return h;
+}
+
+template <class T>
+static T *hash_find(T *const *hash, unsigned mask, const char *name) {
+    if (hash == nullptr)
+        return nullptr;
+    for (unsigned h = hash_name(name) & mask; hash[h] != nullptr; h = (h + 1) & mask) {
+        if (strcmp(hash[h]->name, name) == 0)
+            return hash[h];
+    }
+    return nullptr;
+}
+
+template <class T>
+static void hash_insert(T **hash, unsigned mask, T *item) {
+    unsigned h = hash_name(item->name) & mask;
+    while (hash[h] != nullptr)
+        h = (h + 1) & mask;
+    hash[h] = item;
+}
+
+// add items[n-1] to the index; keep the load factor at or below 1/2
+template <class T>
+static void hash_add(T *const *items, unsigned n, T ***phash, unsigned *pmask) {
+    if (*phash == nullptr || 2 * n > *pmask + 1) {
+        unsigned size = 64;
+        while (size < 4 * n)
+            size *= 2;
+        free(*phash);
+        *phash = static_cast<T **>(calloc(size, sizeof(T *)));
+        assert(*phash != nullptr);
+        *pmask = size - 1;
+        for (unsigned ic = 0; ic < n; ic++)
+            hash_insert(*phash, *pmask, items[ic]);
+        return;
+    }
+    hash_insert(*phash, *pmask, items[n - 1]);
+}
+
 static void internal_error(const char *format, ...) attribute_format(1, 2);
 static void internal_error(const char *format, ...) {
     static char buf[1024];
@@ -119,6 +164,8 @@ ElfLinker::~ElfLinker() {
     for (ic = 0; ic < nrelocations; ic++)
         delete relocations[ic];
     free(relocations);
+    free(section_hash);
+    free(symbol_hash);
 }
 
 void ElfLinker::init(const void *pdata_v, int plen, unsigned pxtra) {
@@ -300,18 +347,18 @@ void ElfLinker::preprocessRelocations(char *start, char const *end) {
 }
 
 ElfLinker::Section *ElfLinker::findSection(const char *name, bool fatal) const {
-    for (unsigned ic = 0; ic < nsections; ic++)
-        if (strcmp(sections[ic]->name, name) == 0)
-            return sections[ic];
+    Section *const section = hash_find(section_hash, section_hash_mask, name);
+    if (section != nullptr)
+        return section;
     if (fatal)
         internal_error("unknown section %s\n", name);
     return nullptr;
 }
 
 ElfLinker::Symbol *ElfLinker::findSymbol(const char *name, bool fatal) const {
-    for (unsigned ic = 0; ic < nsymbols; ic++)
-        if (strcmp(symbols[ic]->name, name) == 0)
-            return symbols[ic];
+    Symbol *const symbol = hash_find(symbol_hash, symbol_hash_mask, name);
+    if (symbol != nullptr)
+        return symbol;
     if (fatal)
         internal_error("unknown symbol %s\n", name);
     return nullptr;
@@ -332,6 +379,7 @@ ElfLinker::Section *ElfLinker::addSection(const char *sname, const void *sdata,
     assert(findSection(sname, false) == nullptr);
     Section *sec = new Section(sname, sdata, slen, p2align);
     sections[nsections++] = sec;
+    hash_add(sections, nsections, &section_hash, &section_hash_mask);
     return sec;
 }
 
@@ -347,6 +395,7 @@ ElfLinker::Symbol *ElfLinker::addSymbol(const char *name, const char *section,
     assert(findSymbol(name, false) == nullptr);
     Symbol *sym = new Symbol(name, findSection(section), offset);
     symbols[nsymbols++] = sym;
+    hash_add(symbols, nsymbols, &symbol_hash, &symbol_hash_mask);
     return sym;
 }
 
@@ -913,4 +962,52 @@ void ElfLinkerX86::relocate1(const Relocation *rel, upx_byte *location, upx_uint
         super::relocate1(rel, location, value, type);
 }
 
+/*************************************************************************
+// tests
+**************************************************************************/
+
+#if !defined(DOCTEST_CONFIG_DISABLE)
+
+static const
+#include "stub/i386-linux.elf.interp-entry.h"
+
+namespace {
+struct TestElfLinker final : public ElfLinker {
+    void checkLookups() const {
+        for (unsigned ic = 0; ic < nsections; ic++)
+            CHECK(findSection(sections[ic]->name) == sections[ic]);
+        for (unsigned ic = 0; ic < nsymbols; ic++)
+            CHECK(findSymbol(symbols[ic]->name) == symbols[ic]);
+        CHECK(findSection("no such section", false) == nullptr);
+        CHECK(findSymbol("no such symbol", false) == nullptr);
+    }
+};
+} // namespace
+
+TEST_CASE("ElfLinker") {
+    TestElfLinker linker;
+    linker.init(stub_i386_linux_elf_interp_entry, sizeof(stub_i386_linux_elf_interp_entry));
+    linker.checkLookups();
+    CHECK(linker.addSection("TEST", "", 0, 0) != nullptr);
+    linker.checkLookups();
+    CHECK_THROWS(linker.getSectionSize("no such section"));
+}
+
+// microbenchmark, opt-in: UPX_DEBUG_DOCTEST_BENCHMARK=1 upx --version
+TEST_CASE("ElfLinker load largest stub") {
+    const char *e = getenv("UPX_DEBUG_DOCTEST_BENCHMARK");
+    if (!e || !e[0] || strcmp(e, "0") == 0)
+        return;
+    const clock_t t0 = clock();
+    for (int i = 0; i < 1000; i++) {
+        TestElfLinker linker;
+        linker.init(stub_i386_linux_elf_interp_entry, sizeof(stub_i386_linux_elf_interp_entry));
+    }
+    const clock_t t1 = clock();
+    MESSAGE("1000 x ElfLinker::init(i386-linux.elf.interp-entry): "
+            << double(t1 - t0) / CLOCKS_PER_SEC << " s");
+}
+
+#endif // DOCTEST_CONFIG_DISABLE
+
 /* vim:set ts=4 sw=4 et: */
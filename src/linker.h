@@ -62,6 +62,12 @@ protected:
     unsigned nrelocations = 0;
     unsigned nrelocations_capacity = 0;
 
+    // open addressing hash indexes by name (ImportLinker sorts sections[])
+    Section **section_hash = nullptr;
+    Symbol **symbol_hash = nullptr;
+    unsigned section_hash_mask = 0;
+    unsigned symbol_hash_mask = 0;
+
     bool reloc_done = false;
 
 protected:
@@ -718,7 +718,10 @@ static int do_option(int optc, const char *arg) {
         opt->atari_tos.split_segments = true;
         break;
     case 660:
-        getoptvar(&opt->o_unix.blocksize, 8192u, ~0u, arg);
+        if (mfx_optarg && strcmp(mfx_optarg, "auto") == 0)
+            opt->o_unix.blocksize_auto = true;
+        else
+            getoptvar(&opt->o_unix.blocksize, 8192u, ~0u, arg);
         break;
     case 661:
         opt->o_unix.force_execve = true;
@@ -769,6 +772,9 @@ static int do_option(int optc, const char *arg) {
     case 677:
         opt->o_unix.force_pie = true;
         break;
+    case 678:
+        getoptvar(&opt->o_unix.unfilter_window, 8192u, ~0u, arg);
+        break;
 
 #if !defined(DOCTEST_CONFIG_DISABLE)
     case 999: // doctest --dt-XXX option
@@ -923,6 +929,7 @@ int main_get_options(int argc, char **argv) {
         {"preserve-build-id", 0, N, 675},
         {"android-shlib", 0, N, 676},
         {"force-pie", 0x90, N, 677},
+        {"unfilter-window", 0x31, N, 678}, // --unfilter-window=
         // watcom/le
         {"le", 0x10, N, 620}, // produce LE output
                               // win32/pe
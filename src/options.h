@@ -133,6 +133,7 @@ struct options_t final {
     } dos_exe;
     struct {
         unsigned blocksize;
+        bool blocksize_auto;    // --blocksize=auto
         bool force_execve;      // force the linux/386 execve format
         bool is_ptinterp;       // is PT_INTERP, so don't adjust auxv_t
         bool use_ptinterp;      // use PT_INTERP /opt/upx/run
@@ -142,6 +143,7 @@ struct options_t final {
         bool preserve_build_id; // copy the build-id to the compressed binary
         bool android_shlib;     // keep some ElfXX_Shdr for dlopen()
         bool force_pie;         // choose DF_1_PIE instead of is_shlib
+        unsigned unfilter_window; // max length of a filtered block
     } o_unix;
     struct {
         bool boot_only;
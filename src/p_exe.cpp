@@ -401,7 +401,7 @@ void PackExe::pack(OutputFile *fo) {
             unsigned jc = get_le32(wr + 4 * ic);
             set_le32(wr + 4 * ic, ((jc >> 16) * 16 + (jc & 0xffff)) & 0xfffff);
         }
-        qsort(wr, ih.relocs, 4, le32_compare);
+        sort_le32(wr, ih.relocs);
         relocsize = optimize_relocs(ibuf, ih_imagesize, wr, ih.relocs, w, &has_9a);
         set_le16(w + relocsize, relocsize + 2);
         relocsize += 2;
@@ -4246,6 +4246,47 @@ unsigned PackLinuxElf32::find_LOAD_gap(
     return lo - hi;
 }
 
+// Collect the file ranges of SHF_EXECINSTR sections, so that packExtent()
+// does not filter .rodata, .eh_frame, .gcc_except_table, etc. which share
+// a PT_LOAD with .text.  Without usable Shdrs then filter every PF_X byte.
+// Not for a shared library: its stub de-compresses exactly one block
+// per PT_LOAD, and does not unfilter.
+void PackLinuxElf32::find_xct_ranges()
+{
+    n_xct = -1;
+    if (xct_off) { // shared library
+        return;
+    }
+    unsigned const shnum = get_te16(&ehdri.e_shnum);
+    unsigned const shoff = get_te32(&ehdri.e_shoff);
+    if (!shnum || sizeof(Elf32_Shdr) != get_te16(&ehdri.e_shentsize)
+    ||  (unsigned)file_size < shoff
+    ||  (((unsigned)file_size - shoff) / sizeof(Elf32_Shdr)) < shnum) {
+        return;
+    }
+    MemBuffer mb_shdr(shnum * sizeof(Elf32_Shdr));
+    Elf32_Shdr const *shdr = (Elf32_Shdr const *)mb_shdr.getVoidPtr();
+    fi->seek(shoff, SEEK_SET);
+    fi->readx(mb_shdr, mb_shdr.getSize());
+
+    mb_xct.alloc(shnum * sizeof(Extent));
+    Extent *const xr = (Extent *)mb_xct.getVoidPtr();
+    n_xct = 0;
+    for (unsigned j = 0; j < shnum; ++shdr, ++j) {
+        unsigned const sh_offset = get_te32(&shdr->sh_offset);
+        unsigned const sh_size   = get_te32(&shdr->sh_size);
+        if (Elf32_Shdr::SHT_NOBITS != get_te32(&shdr->sh_type)
+        &&  (Elf32_Shdr::SHF_EXECINSTR & get_te32(&shdr->sh_flags))
+        &&  sh_size && sh_offset <= (unsigned)file_size
+        &&  sh_size <= ((unsigned)file_size - sh_offset)) {
+            xr[n_xct].offset = sh_offset;
+            xr[n_xct].size   = sh_size;
+            ++n_xct;
+        }
+    }
+    sort_xct();
+}
+
 int PackLinuxElf32::pack2(OutputFile *fo, Filter &ft)
 {
     Extent x;
@@ -4272,6 +4313,7 @@ int PackLinuxElf32::pack2(OutputFile *fo, Filter &ft)
 
     uip->ui_pass = 0;
     ft.addvalue = 0;
+    find_xct_ranges();
 
     unsigned nk_f = 0; unsigned xsz_f = 0;
     for (k = 0; k < e_phnum; ++k)
@@ -4312,7 +4354,7 @@ int PackLinuxElf32::pack2(OutputFile *fo, Filter &ft)
             // sometimes marks as PF_X anyway.  So filter only first segment.
             if (k == nk_f || !is_shlib) {
                 packExtent(x,
-                    (k==nk_f ? &ft : nullptr ), fo, hdr_u_len);
+                    (k==nk_f ? &ft : nullptr ), fo, hdr_u_len, 0, true);
             }
             else {
                 total_in += x.size;
@@ -4377,6 +4419,47 @@ unsigned PackLinuxElf64::find_LOAD_gap(
     return lo - hi;
 }
 
+// Collect the file ranges of SHF_EXECINSTR sections, so that packExtent()
+// does not filter .rodata, .eh_frame, .gcc_except_table, etc. which share
+// a PT_LOAD with .text.  Without usable Shdrs then filter every PF_X byte.
+// Not for a shared library: its stub de-compresses exactly one block
+// per PT_LOAD, and does not unfilter.
+void PackLinuxElf64::find_xct_ranges()
+{
+    n_xct = -1;
+    if (xct_off) { // shared library
+        return;
+    }
+    unsigned const shnum = get_te16(&ehdri.e_shnum);
+    upx_uint64_t const shoff = get_te64(&ehdri.e_shoff);
+    if (!shnum || sizeof(Elf64_Shdr) != get_te16(&ehdri.e_shentsize)
+    ||  (upx_uint64_t)file_size < shoff
+    ||  (((upx_uint64_t)file_size - shoff) / sizeof(Elf64_Shdr)) < shnum) {
+        return;
+    }
+    MemBuffer mb_shdr(shnum * sizeof(Elf64_Shdr));
+    Elf64_Shdr const *shdr = (Elf64_Shdr const *)mb_shdr.getVoidPtr();
+    fi->seek(shoff, SEEK_SET);
+    fi->readx(mb_shdr, mb_shdr.getSize());
+
+    mb_xct.alloc(shnum * sizeof(Extent));
+    Extent *const xr = (Extent *)mb_xct.getVoidPtr();
+    n_xct = 0;
+    for (unsigned j = 0; j < shnum; ++shdr, ++j) {
+        upx_uint64_t const sh_offset = get_te64(&shdr->sh_offset);
+        upx_uint64_t const sh_size   = get_te64(&shdr->sh_size);
+        if (Elf64_Shdr::SHT_NOBITS != get_te32(&shdr->sh_type)
+        &&  (Elf64_Shdr::SHF_EXECINSTR & get_te64(&shdr->sh_flags))
+        &&  sh_size && sh_offset <= (upx_uint64_t)file_size
+        &&  sh_size <= ((upx_uint64_t)file_size - sh_offset)) {
+            xr[n_xct].offset = sh_offset;
+            xr[n_xct].size   = sh_size;
+            ++n_xct;
+        }
+    }
+    sort_xct();
+}
+
 int PackLinuxElf64::pack2(OutputFile *fo, Filter &ft)
 {
     Extent x;
@@ -4430,6 +4513,7 @@ int PackLinuxElf64::pack2(OutputFile *fo, Filter &ft)
     total_out = 0;
     uip->ui_pass = 0;
     ft.addvalue = 0;
+    find_xct_ranges();
 
     if (is_shlib) { // prepare to alter Phdrs and Shdrs
         lowmem.alloc(xct_off + (!is_asl
@@ -54,6 +54,8 @@ protected:
     virtual int  pack2(OutputFile *, Filter &) override = 0;  // append compressed data
     virtual off_t pack3(OutputFile *, Filter &) override = 0;  // append loader
     //virtual void pack4(OutputFile *, Filter &) override = 0;  // append pack header
+    // The shlib-init stubs always de-compress.
+    virtual bool canStoreBlock() const override { return 0 == xct_off; }
 
     virtual void generateElfHdr(
         OutputFile *,
@@ -161,6 +163,7 @@ protected:
     virtual void updateLoader(OutputFile *fo) override;
     virtual unsigned find_LOAD_gap(Elf32_Phdr const *const phdri, unsigned const k,
         unsigned const e_phnum);
+    virtual void find_xct_ranges();  // SHF_EXECINSTR ==> mb_xct, n_xct
     virtual off_t getbase(const Elf32_Phdr *phdr, int e_phnum) const;
     bool calls_crt1(Elf32_Rel const *rel, int sz);
 
@@ -315,6 +318,7 @@ protected:
     virtual void updateLoader(OutputFile *fo) override;
     virtual unsigned find_LOAD_gap(Elf64_Phdr const *const phdri, unsigned const k,
         unsigned const e_phnum);
+    virtual void find_xct_ranges();  // SHF_EXECINSTR ==> mb_xct, n_xct
     bool calls_crt1(Elf64_Rela const *rela, int sz);
 
     virtual Elf64_Sym const *elf_lookup(char const *) const;
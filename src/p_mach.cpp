@@ -1193,7 +1193,7 @@ int  PackMachBase<T>::pack2(OutputFile *fo, Filter &ft)  // append compressed bo
             ptr = (Mach_segment_command const *)(ptr->cmdsize + (char const *)ptr);
         }
         packExtent(x,
-            (do_filter ? &ft : nullptr), fo, hdr_u_len, b_extra );
+            (do_filter ? &ft : nullptr), fo, hdr_u_len, b_extra, true);
         if (do_filter) {
             exe_filesize_max = 0;
         }
@@ -40,6 +40,10 @@
 
 // do not change
 #define BLOCKSIZE       (512*1024)
+// --blocksize=auto tolerates this many percent more compressed bytes
+#define AUTO_BLOCKSIZE_LOSS_PCT 1
+// shortest sub-block of a split Extent which is worth filtering
+#define XCT_MIN_FILTER  (4*1024)
 
 
 /*************************************************************************
@@ -47,7 +51,7 @@
 **************************************************************************/
 
 PackUnix::PackUnix(InputFile *f) :
-    super(f), exetype(0), blocksize(0), overlay_offset(0), lsize(0),
+    super(f), n_xct(-1), xct_ftid(0), xct_cto(0), xct_n_mru(0), exetype(0), blocksize(0), overlay_offset(0), lsize(0),
     methods_used(0)
 {
     COMPILE_TIME_ASSERT(sizeof(Elf32_Ehdr) == 52)
@@ -272,12 +276,64 @@ void PackUnix::pack4(OutputFile *fo, Filter &)
     fo->write(&tmp, sizeof(tmp));
 }
 
+// --blocksize=auto: a smaller block needs less memory to unpack,
+// a larger block compresses better.  Compress a sample from the middle
+// of the file in blocks of max_blocksize, max_blocksize/2, ...  and
+// choose the smallest which costs at most AUTO_BLOCKSIZE_LOSS_PCT percent
+// more than max_blocksize.
+
+// c_lens[j] is the compressed size at blocksize (max_blocksize >> j).
+static int auto_blocksize_pick(unsigned const *c_lens, int n)
+{
+    unsigned const limit = c_lens[0] + (c_lens[0] / 100) * AUTO_BLOCKSIZE_LOSS_PCT;
+    int best = 0;
+    for (int j = 1; j < n; ++j) {
+        if (c_lens[j] <= limit)
+            best = j;
+    }
+    return best;
+}
+
+unsigned PackUnix::auto_blocksize(unsigned const max_blocksize)
+{
+    enum { MIN_AUTO = 64 * 1024, MAX_TRY = 8 };
+    unsigned const len = max_blocksize;
+    if (len < 2 * MIN_AUTO || file_size < (off_t)len)
+        return max_blocksize;
+    MemBuffer sample(len);
+    MemBuffer cbuf;
+    cbuf.allocForCompression(len);
+    fi->seek((file_size - len) / 2, SEEK_SET);
+    fi->readx(sample, len);
+
+    unsigned sizes[MAX_TRY];
+    unsigned c_lens[MAX_TRY];
+    int n = 0;
+    for (unsigned bs = len; MIN_AUTO <= bs && n < MAX_TRY; bs >>= 1, ++n) {
+        unsigned total = 0;
+        for (unsigned off = 0; off < len; off += bs) {
+            unsigned const u_len = UPX_MIN(bs, len - off);
+            unsigned c_len = 0;
+            int r = upx_compress(sample + off, u_len, cbuf, &c_len, nullptr,
+                forced_method(ph.method), ph.level, nullptr, nullptr);
+            total += (r == UPX_E_OK && c_len < u_len) ? c_len : u_len;
+        }
+        sizes[n] = bs;
+        c_lens[n] = total;
+    }
+    int const best = auto_blocksize_pick(c_lens, n);
+    info("Auto blocksize %u: sample %u -> %u (%u at blocksize %u)",
+        sizes[best], len, c_lens[best], c_lens[0], sizes[0]);
+    return sizes[best];
+}
+
 void PackUnix::pack(OutputFile *fo)
 {
     Filter ft(ph.level);
     ft.addvalue = 0;
     b_len = 0;
     progid = 0;
+    xct_ftid = 0;  // no filter chosen yet for packExtent()
 
     // set options
     blocksize = opt->o_unix.blocksize;
@@ -285,6 +341,12 @@ void PackUnix::pack(OutputFile *fo)
         blocksize = BLOCKSIZE;
     if ((off_t)blocksize > file_size)
         blocksize = file_size;
+    if (opt->o_unix.blocksize_auto) {
+        if (0 == opt->o_unix.blocksize)
+            blocksize = auto_blocksize(blocksize);
+        else // canPack() fixed it from the layout (linux/elf, linux.sh, Mach-O)
+            infoWarning("--blocksize=auto ignored: one block per segment");
+    }
 
     // init compression buffers
     ibuf.alloc(blocksize);
@@ -300,12 +362,17 @@ void PackUnix::pack(OutputFile *fo)
     fo->write(&hbuf, sizeof(hbuf));
 
     // append the compressed body
+    forgetTrialLoaderSizes();  // pack1() may have tried with other state
     if (pack2(fo, ft)) {
         // write block end marker (uncompressed size 0)
         b_info hdr; memset(&hdr, 0, sizeof(hdr));
         set_le32(&hdr.sz_cpr, UPX_MAGIC_LE32);
         fo->write(&hdr, sizeof(hdr));
     }
+    // Only the main program of linux/elf (known SHF_EXECINSTR ranges)
+    // is split into windows; see filter_xct().
+    if (opt->o_unix.unfilter_window && n_xct < 0)
+        infoWarning("--unfilter-window ignored: not a linux/elf main program with section headers");
 
     pack3(fo, ft);  // append loader
 
@@ -317,9 +384,78 @@ void PackUnix::pack(OutputFile *fo)
 }
 
 
+int __acc_cdecl_qsort
+PackUnix::compare_Extent(void const *aa, void const *bb)
+{
+    off_t const a = ((Extent const *)aa)->offset;
+    off_t const b = ((Extent const *)bb)->offset;
+    return (a < b) ? -1 : (b < a);
+}
+
+void PackUnix::sort_xct()
+{
+    if (n_xct <= 0)
+        return;
+    Extent *const xr = (Extent *)mb_xct.getVoidPtr();
+    qsort(xr, n_xct, sizeof(*xr), compare_Extent);
+    // The stub does not unfilter a short block in the middle of an Extent
+    // (see filter_xct), so a short gap between instructions is not worth
+    // a separate block.  Coalesce.
+    int j = 0;
+    for (int k = 1; k < n_xct; ++k) {
+        off_t const hi = xr[j].offset + xr[j].size;
+        if (xr[k].offset <= (512 + hi)) {
+            xr[j].size = UPX_MAX(hi, xr[k].offset + xr[k].size) - xr[j].offset;
+        }
+        else {
+            xr[++j] = xr[k];
+        }
+    }
+    n_xct = 1+ j;
+}
+
+// Choose the length and the filter of the next block at file offset 'pos'.
+// A block which straddles the boundary of instructions is shortened, so that
+// rodata, .eh_frame, etc. are not filtered (no false call-trick rewrites).
+Filter *PackUnix::filter_xct(off_t pos, off_t &len, Filter *ft) const
+{
+    if (!ft || n_xct < 0) // unknown ranges: keep the whole block
+        return ft;
+    Extent const *const xr = (Extent const *)mb_xct.getVoidPtr();
+    int k = 0;
+    for (; k < n_xct; ++k) {
+        off_t const hi = xr[k].offset + xr[k].size;
+        if (pos < hi) {
+            break;
+        }
+    }
+    if (n_xct <= k) { // no more instructions
+        return nullptr;
+    }
+    if (pos < xr[k].offset) { // data up to next instructions
+        len = UPX_MIN(len, xr[k].offset - pos);
+        return nullptr;
+    }
+    len = UPX_MIN(len, xr[k].offset + xr[k].size - pos);
+    // The stub unfilters each block right after de-compressing it.
+    // (Reached only for a main program; a shlib keeps (n_xct < 0).)
+    // A short block is unfiltered while it still is in the cache,
+    // instead of streaming the whole segment through memory twice.
+    if (opt->o_unix.unfilter_window) {
+        len = UPX_MIN(len, (off_t)opt->o_unix.unfilter_window);
+    }
+    // Filtering a short sub-block gains little and would need its own
+    // compressWithFilters() trial.  (Also, the stub skips unfiltering
+    // a block of 512 bytes or less unless it is last in its Extent.)
+    if (len < XCT_MIN_FILTER) {
+        return nullptr;
+    }
+    return ft;
+}
+
 void PackUnix::packExtent(
     const Extent &x,
-    Filter *ft,
+    Filter *x_ft,
     OutputFile *fo,
     unsigned hdr_u_len,
     unsigned b_extra,
@@ -337,8 +473,10 @@ void PackUnix::packExtent(
     }
     fi->seek(x.offset, SEEK_SET);
     for (off_t rest = x.size; 0 != rest; ) {
-        int const filter_strategy = ft ? getStrategy(*ft) : 0;
-        int l = fi->readx(ibuf, UPX_MIN(rest, (off_t)blocksize));
+        off_t len = UPX_MIN(rest, (off_t)blocksize);
+        Filter *const ft = filter_xct(x.offset + x.size - rest, len, x_ft);
+        int filter_strategy = ft ? getStrategy(*ft) : 0;
+        int l = fi->readx(ibuf, len);
         if (l == 0) {
             break;
         }
@@ -350,6 +488,8 @@ void PackUnix::packExtent(
         // compress
         ph.c_len = ph.u_len = l;
         ph.overlap_overhead = 0;
+        // compress() sets it too, but not if every trial fails
+        ph.saved_c_adler = ph.c_adler;
         unsigned end_u_adler = 0;
         if (ft) {
             // compressWithFilters() updates u_adler _inside_ compress();
@@ -364,8 +504,28 @@ void PackUnix::packExtent(
             ft->id = 0;
             ft->cto = 0;
 
+            // The stub is linked with the unfilter for one filter id only,
+            // so every later block must use the id (and preferably the cto)
+            // chosen for the first filtered block.
+            struct OptFilter { // restore opt->filter, even if compression throws
+                int const saved;
+                OptFilter() : saved(opt->filter) {}
+                ~OptFilter() { opt->filter = saved; }
+            } opt_filter;
+            int preferred_ctos[2] = { xct_cto, -1 };
+            if (xct_ftid) {
+                opt->filter = xct_ftid;
+                filter_strategy = -2;
+                ft->preferred_ctos = preferred_ctos;
+            }
             compressWithFilters(ft, OVERHEAD, NULL_cconf, filter_strategy,
                                 0, 0, 0, hdr_ibuf, hdr_u_len, inhibit_compression_check);
+            ft->preferred_ctos = nullptr;
+            if (!xct_ftid && ft->id) {
+                xct_ftid = ft->id;
+                xct_cto = ft->cto;
+                xct_n_mru = ft->n_mru;
+            }
         }
         else {
             (void) compress(ibuf, ph.u_len, obuf);    // ignore return value
@@ -380,12 +540,20 @@ void PackUnix::packExtent(
                 ph.c_len = ph.u_len;
             }
         }
+        if (ph.c_len < ph.u_len && (ph.u_len - ph.c_len) < (ph.u_len >> 7)
+        &&  canStoreBlock()) {
+            // Saving less than 1/128 of the block (already-compressed data,
+            // media, etc.) is not worth de-compressing it at run time.
+            // The stub copies a stored block instead.
+            ph.c_len = ph.u_len;
+        }
         if (ph.c_len >= ph.u_len) {
             // block is not compressible
             ph.c_len = ph.u_len;
             memcpy(obuf, ibuf, ph.c_len);
-            // must update checksum of compressed data
-            ph.c_adler = upx_adler32(ibuf, ph.u_len, ph.c_adler);
+            // must update checksum of compressed data; compress() may
+            // already have added the (discarded) compressed bytes
+            ph.c_adler = upx_adler32(ibuf, ph.u_len, ph.saved_c_adler);
         }
 
         // write block sizes
@@ -450,6 +618,15 @@ void PackUnix::packExtent(
 
         total_in += ph.u_len;
     }
+    if (x_ft && xct_ftid) {
+        // A later block may have fallen back to no filter (id 0), and
+        // compressWithFilters() built the loader for that block's filter.
+        // Rebuild it with the unfilter of the pinned id.
+        x_ft->id = xct_ftid;
+        x_ft->cto = xct_cto;
+        x_ft->n_mru = xct_n_mru;
+        buildLoader(x_ft);
+    }
 }
 
 // Consumes b_info header block and sz_cpr data block from input file 'fi'.
@@ -688,4 +865,19 @@ void PackUnix::unpack(OutputFile *fo)
         throwChecksumError();
 }
 
+/*************************************************************************
+//
+**************************************************************************/
+
+TEST_CASE("auto_blocksize_pick") {
+    // compressed sizes at blocksize 512K, 256K, 128K, 64K
+    const unsigned flat[4] = {100000, 100500, 100999, 101000};
+    CHECK(auto_blocksize_pick(flat, 4) == 3);  // 64K costs exactly 1% more
+    const unsigned steep[4] = {100000, 100900, 101100, 100950};
+    CHECK(auto_blocksize_pick(steep, 4) == 3);  // smallest within 1%
+    const unsigned worse[4] = {100000, 101001, 102000, 104000};
+    CHECK(auto_blocksize_pick(worse, 4) == 0);
+    CHECK(auto_blocksize_pick(worse, 1) == 0);
+}
+
 /* vim:set ts=4 sw=4 et: */
@@ -57,6 +57,10 @@ public:
     int find_overlay_offset(MemBuffer const &buf);
 
 protected:
+    // For LZMA, buildLoader() also reads ph.u_len, ph.c_len (linux.exec)
+    // and the lzma properties of the compressed block.
+    virtual bool canMemoizeLoaderSize() const override { return !M_IS_LZMA(ph.method); }
+
     // called by the generic pack()
     virtual void pack1(OutputFile *, Filter &);  // generate executable header
     virtual int  pack2(OutputFile *, Filter &);  // append compressed data
@@ -70,6 +74,8 @@ protected:
     virtual void writePackHeader(OutputFile *fo);
 
     virtual bool checkCompressionRatio(unsigned, unsigned) const override;
+    // Can the stub copy a block which packExtent() chose to store?
+    virtual bool canStoreBlock() const { return true; }
 
 protected:
     struct Extent {
@@ -87,6 +93,21 @@ protected:
         );
     unsigned total_in, total_out;  // unpack
 
+    // File ranges that hold instructions, as sorted disjoint Extents.
+    // packExtent() applies the filter only to blocks inside these ranges.
+    // (n_xct < 0) means unknown (or a shared library): neither split
+    // nor skip any block of the Extent; filter every block.
+    MemBuffer mb_xct;
+    int n_xct;
+    void sort_xct();  // sort and coalesce mb_xct[0, n_xct)
+    unsigned auto_blocksize(unsigned max_blocksize);  // --blocksize=auto
+    static int __acc_cdecl_qsort compare_Extent(void const *, void const *);
+    Filter *filter_xct(off_t pos, off_t &len, Filter *ft) const;
+    // Filter of the first filtered block; packExtent() pins it for the rest.
+    int xct_ftid;
+    int xct_cto;
+    unsigned xct_n_mru;
+
     int exetype;
     unsigned blocksize;
     unsigned progid;              // program id
@@ -836,7 +836,7 @@ unsigned Packer::optimizeReloc(SPAN_P(upx_byte) in, unsigned relocnum, SPAN_P(up
     *big = 0;
     if (relocnum == 0)
         return 0;
-    qsort(raw_bytes(in, 4 * relocnum), relocnum, 4, le32_compare);
+    sort_le32(raw_bytes(in, 4 * relocnum), relocnum);
 
     unsigned jc, pc, oc;
     SPAN_P_VAR(upx_byte, fix, out);
@@ -1324,6 +1324,7 @@ void Packer::compressWithFilters(upx_bytep i_ptr,
             // get fresh filter
             Filter ft = orig_ft;
             ft.init(ph.filter, orig_ft.addvalue);
+            ft.preferred_ctos = orig_ft.preferred_ctos;  // input parameter
             // filter
             optimizeFilter(&ft, f_ptr, f_len);
             bool success = ft.filter(f_ptr, f_len);
@@ -1361,8 +1362,7 @@ void Packer::compressWithFilters(upx_bytep i_ptr,
                     best_ph.c_len + best_ph_lsize + best_hdr_c_len) {
                     // get results
                     ph.overlap_overhead = findOverlapOverhead(o_tmp, i_ptr, overlap_range);
-                    buildLoader(&ft);
-                    lsize = getLoaderSize();
+                    lsize = getTrialLoaderSize(&ft);
                     assert(lsize > 0);
                 }
 #if 0  //{
@@ -1431,6 +1431,36 @@ void Packer::compressWithFilters(upx_bytep i_ptr,
     buildLoader(&best_ft);
 }
 
+// Size of the loader for ph.method and 'ft', as used to rank the candidates
+// in compressWithFilters().  buildLoader() re-creates the linker and
+// re-parses the stub, yet every block of a multi-block pack (and each
+// method trial of PackLinuxElf64::pack1) tries the same candidates again.
+// Only the size is remembered: compressWithFilters() always finishes
+// with a real buildLoader(&best_ft).  The key is method, filter id, n_mru
+// and cto; packers whose buildLoader() also reads ph.u_len, ph.c_len, etc.
+// (PackExe, djgpp2, vmlinuz) do not opt in.
+unsigned Packer::getTrialLoaderSize(const Filter *ft) {
+    if (!canMemoizeLoaderSize()) {
+        buildLoader(ft);
+        return getLoaderSize();
+    }
+    // linux.sh filters its fold with ft->cto, linux.exec defines "filter_cto"
+    upx_uint64_t const key = (0xff & ph.method) | ((0xff & ft->id) << 8) |
+                             ((0x1ff & ft->n_mru) << 16) | ((upx_uint64_t) (0xff & ft->cto) << 25);
+    for (unsigned j = 0; j < n_trial_lsize; ++j) {
+        if (trial_lsize[j].key == key)
+            return trial_lsize[j].lsize;
+    }
+    buildLoader(ft);
+    unsigned const lsize = getLoaderSize();
+    if (n_trial_lsize < TABLESIZE(trial_lsize)) {
+        trial_lsize[n_trial_lsize].key = key;
+        trial_lsize[n_trial_lsize].lsize = lsize;
+        ++n_trial_lsize;
+    }
+    return lsize;
+}
+
 /*************************************************************************
 //
 **************************************************************************/
@@ -207,6 +207,10 @@ protected:
 
     // loader core
     virtual void buildLoader(const Filter *ft) = 0;
+    unsigned getTrialLoaderSize(const Filter *ft); // memoized, for compression trials
+    // true if buildLoader() depends only on ph.method, ft->id, ft->n_mru, ft->cto
+    virtual bool canMemoizeLoaderSize() const { return false; }
+    void forgetTrialLoaderSizes() { n_trial_lsize = 0; }
     virtual Linker *newLinker() const = 0;
     virtual void relocateLoader();
     // loader util for linker
@@ -326,6 +330,14 @@ private:
     int last_patch_len;
     int last_patch_off;
 
+    // private to getTrialLoaderSize()
+    struct TrialLoaderSize {
+        upx_uint64_t key; // method, filter id, n_mru, cto
+        unsigned lsize;
+    };
+    TrialLoaderSize trial_lsize[64];
+    unsigned n_trial_lsize = 0;
+
 private:
     // disable copy and assignment
     Packer(const Packer &) = delete;
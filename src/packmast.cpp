@@ -129,6 +129,151 @@ static Packer *try_unpack(Packer *p, void *user) {
     return nullptr;
 }
 
+/*************************************************************************
+// container detection
+//
+// Look at the first bytes of the file once, so that visitAllPackers()
+// does not have to construct and probe packers which are bound to fail.
+// A group is only skipped if both canPack() and canUnpack() of all its
+// members reject the file on the magic number at offset 0; files that
+// are not recognized here still try every packer.
+**************************************************************************/
+
+namespace {
+enum : unsigned {
+    FT_DOS = 1,          // "MZ", COFF, "BW", "LE", "PMW1", "Adam": djgpp2, tmt, wcle, pe, exe
+    FT_TOS = 2,          // 0x601a
+    FT_ELF = 4,          // vmlinux and linux/elf, see elf_machine
+    FT_ZIMAGE_ARM = 8,   // 8 * "mov r0,r0"
+    FT_PS1 = 16,         // "PS-X EXE"
+    FT_MACH = 32,        // Mach-O
+    FT_MACH_FAT = 64,    // Mach-O universal; also Java class files
+    FT_ANY = ~0u,
+};
+struct ContainerInfo {
+    unsigned ft;
+    unsigned elf_machine; // e_machine, or 0 if unknown
+};
+} // namespace
+
+static ContainerInfo getContainerInfo(InputFile *f) {
+    ContainerInfo ci = {FT_ANY, 0};
+    if (f == nullptr) // PackerNames::visit()
+        return ci;
+    unsigned char h[32];
+    int len = 0;
+    try {
+        f->seek(0, SEEK_SET);
+        len = f->read(h, sizeof(h));
+        f->seek(0, SEEK_SET);
+    } catch (const IOException &) {
+        return ci;
+    }
+    if (len < 4)
+        return ci;
+    const unsigned m_le = get_le32(h);
+    const unsigned m_be = get_be32(h);
+    if (memcmp(h, "MZ", 2) == 0 || memcmp(h, "ZM", 2) == 0)
+        ci.ft = FT_DOS;
+    else if (get_le16(h) == 0x014c) // bare COFF (djgpp2, "upx --coff")
+        ci.ft = FT_DOS;
+    else if (memcmp(h, "BW", 2) == 0 || memcmp(h, "LE", 2) == 0 || memcmp(h, "PMW1", 4) == 0 ||
+             memcmp(h, "Adam", 4) == 0) // tmt, wcle without a DOS stub
+        ci.ft = FT_DOS;
+    else if (memcmp(h, "\x7f\x45\x4c\x46", 4) == 0) {
+        ci.ft = FT_ELF;
+        if (len >= 20 && h[Elf32_Ehdr::EI_DATA] == Elf32_Ehdr::ELFDATA2LSB)
+            ci.elf_machine = get_le16(h + 18);
+        else if (len >= 20 && h[Elf32_Ehdr::EI_DATA] == Elf32_Ehdr::ELFDATA2MSB)
+            ci.elf_machine = get_be16(h + 18);
+    } else if (m_be == 0xcafebabe)
+        ci.ft = FT_MACH_FAT;
+    else if (m_le == 0xfeedface || m_le == 0xfeedfacf || m_be == 0xfeedface ||
+             m_be == 0xfeedfacf)
+        ci.ft = FT_MACH;
+    else if (get_be16(h) == 0x601a)
+        ci.ft = FT_TOS;
+    else if (len >= 8 && (memcmp(h, "PS-X EXE", 8) == 0 || memcmp(h, "EXE X-SP", 8) == 0))
+        ci.ft = FT_PS1;
+    else if (len >= 32) {
+        // same test as PackVmlinuzARMEL::readFileHeader()
+        int j = 0;
+        while (j < 8 && get_le32(h + 4 * j) == 0xe1a00000)
+            j++;
+        if (j == 8)
+            ci.ft = FT_ZIMAGE_ARM;
+    }
+    return ci;
+}
+
+/*************************************************************************
+// -l, -t, -d and --fileinfo: look at the trailer first
+//
+// The Unix formats put the PackHeader at the end of the file, so for
+// ELF and Mach-O input a bounded tail read usually tells the format.
+// Then only the packers that can unpack this format are probed; if none
+// of them accepts the file we fall back to trying all packers.
+**************************************************************************/
+
+static int getTrailerFormat(InputFile *f) {
+    const ContainerInfo ci = getContainerInfo(f);
+    if (!(ci.ft & (FT_ELF | FT_MACH | FT_MACH_FAT)) || ci.ft == FT_ANY)
+        return 0;
+    // same window as PackUnix::canUnpack()
+    const int small = 32 + 4;
+    int bufsize = 2 * 4096 + 2 * small + 1;
+    if (bufsize > f->st_size())
+        bufsize = (int) f->st_size();
+    if (bufsize < small)
+        return 0;
+    MemBuffer buf(bufsize);
+    try {
+        f->seek(-(upx_off_t) bufsize, SEEK_END);
+        f->readx(buf, bufsize);
+        f->seek(0, SEEK_SET);
+    } catch (const IOException &) {
+        return 0;
+    }
+    int i = bufsize;
+    while (i > small && 0 == buf[--i]) {
+    }
+    i -= small;
+    if (i < 0)
+        return 0;
+    const int boff = find_le32(buf + i, bufsize - i, UPX_MAGIC_LE32);
+    if (boff < 0 || i + boff + 8 > bufsize)
+        return 0;
+    return buf[i + boff + 5];
+}
+
+namespace {
+struct UnpackFormat {
+    InputFile *f;
+    int format;
+};
+} // namespace
+
+static Packer *try_unpack_format(Packer *p, void *user) {
+    if (p == nullptr)
+        return nullptr;
+    const UnpackFormat *uf = (const UnpackFormat *) user;
+    if (!p->canUnpackFormat(uf->format)) {
+        delete p;
+        return nullptr;
+    }
+    return try_unpack(p, uf->f);
+}
+
+static Packer *findUnpacker(InputFile *f) {
+    UnpackFormat uf = {f, getTrailerFormat(f)};
+    Packer *pp = nullptr;
+    if (uf.format > 0)
+        pp = PackMaster::visitAllPackers(try_unpack_format, f, opt, &uf);
+    if (!pp)
+        pp = PackMaster::visitAllPackers(try_unpack, f, opt, f);
+    return pp;
+}
+
 /*************************************************************************
 //
 **************************************************************************/
@@ -136,6 +281,7 @@ static Packer *try_unpack(Packer *p, void *user) {
 Packer *PackMaster::visitAllPackers(visit_func_t func, InputFile *f, const options_t *o,
                                     void *user) {
     Packer *p = nullptr;
+    const ContainerInfo ci = getContainerInfo(f);
 
 #define D(Klass)                                                                                   \
     ACC_BLOCK_BEGIN                                                                                \
@@ -146,70 +292,97 @@ Packer *PackMaster::visitAllPackers(visit_func_t func, InputFile *f, const optio
     if ((p = func(kp, user)) != nullptr)                                                           \
         return p;                                                                                  \
     ACC_BLOCK_END
+#define WANT(x) ((ci.ft & (x)) != 0)
+#define WANT_ELF(em) (WANT(FT_ELF) && (ci.elf_machine == 0 || ci.elf_machine == (em)))
 
     // note: order of tries is important !
 
     //
     // .exe
     //
-    if (!o->dos_exe.force_stub) {
-        D(PackDjgpp2);
-        D(PackTmt);
-        D(PackWcle);
-        D(PackW64Pep);
-        D(PackW32Pe);
+    if (WANT(FT_DOS)) {
+        if (!o->dos_exe.force_stub) {
+            D(PackDjgpp2);
+            D(PackTmt);
+            D(PackWcle);
+            D(PackW64Pep);
+            D(PackW32Pe);
+        }
+        D(PackArmPe);
+        D(PackExe);
     }
-    D(PackArmPe);
-    D(PackExe);
 
     //
     // atari
     //
-    D(PackTos);
+    if (WANT(FT_TOS))
+        D(PackTos);
 
     //
     // linux kernel
     //
-    D(PackVmlinuxARMEL);
-    D(PackVmlinuxARMEB);
-    D(PackVmlinuxPPC32);
-    D(PackVmlinuxPPC64LE);
-    D(PackVmlinuxAMD64);
-    D(PackVmlinuxI386);
+    if (WANT_ELF(Elf32_Ehdr::EM_ARM)) {
+        D(PackVmlinuxARMEL);
+        D(PackVmlinuxARMEB);
+    }
+    if (WANT_ELF(Elf32_Ehdr::EM_PPC))
+        D(PackVmlinuxPPC32);
+    if (WANT_ELF(Elf64_Ehdr::EM_PPC64))
+        D(PackVmlinuxPPC64LE);
+    if (WANT_ELF(Elf64_Ehdr::EM_X86_64))
+        D(PackVmlinuxAMD64);
+    if (WANT_ELF(Elf32_Ehdr::EM_386))
+        D(PackVmlinuxI386);
+    // bzImage may start with "MZ" (EFI stub), so always try these
     D(PackVmlinuzI386);
     D(PackBvmlinuzI386);
-    D(PackVmlinuzARMEL);
+    if (WANT(FT_ZIMAGE_ARM))
+        D(PackVmlinuzARMEL);
 
     //
     // linux
     //
     if (!o->o_unix.force_execve) {
-        if (o->o_unix.use_ptinterp) {
-            D(PackLinuxElf32x86interp);
+        if (WANT_ELF(Elf32_Ehdr::EM_386)) {
+            if (o->o_unix.use_ptinterp) {
+                D(PackLinuxElf32x86interp);
+            }
+            D(PackFreeBSDElf32x86);
+            D(PackNetBSDElf32x86);
+            D(PackOpenBSDElf32x86);
+            D(PackLinuxElf32x86);
+        }
+        if (WANT_ELF(Elf64_Ehdr::EM_X86_64))
+            D(PackLinuxElf64amd);
+        if (WANT_ELF(Elf32_Ehdr::EM_ARM)) {
+            D(PackLinuxElf32armLe);
+            D(PackLinuxElf32armBe);
+        }
+        if (WANT_ELF(Elf64_Ehdr::EM_AARCH64))
+            D(PackLinuxElf64arm);
+        if (WANT_ELF(Elf32_Ehdr::EM_PPC))
+            D(PackLinuxElf32ppc);
+        if (WANT_ELF(Elf64_Ehdr::EM_PPC64)) {
+            D(PackLinuxElf64ppc);
+            D(PackLinuxElf64ppcle);
+        }
+        if (WANT_ELF(Elf32_Ehdr::EM_MIPS)) {
+            D(PackLinuxElf32mipsel);
+            D(PackLinuxElf32mipseb);
         }
-        D(PackFreeBSDElf32x86);
-        D(PackNetBSDElf32x86);
-        D(PackOpenBSDElf32x86);
-        D(PackLinuxElf32x86);
-        D(PackLinuxElf64amd);
-        D(PackLinuxElf32armLe);
-        D(PackLinuxElf32armBe);
-        D(PackLinuxElf64arm);
-        D(PackLinuxElf32ppc);
-        D(PackLinuxElf64ppc);
-        D(PackLinuxElf64ppcle);
-        D(PackLinuxElf32mipsel);
-        D(PackLinuxElf32mipseb);
         D(PackLinuxI386sh);
     }
+    // canUnpack() of these only looks at the end of the file
     D(PackBSDI386);
-    D(PackMachFat);   // cafebabe conflict
-    D(PackLinuxI386); // cafebabe conflict
+    if (WANT(FT_MACH_FAT))
+        D(PackMachFat); // cafebabe conflict
+    D(PackLinuxI386);   // cafebabe conflict
 
     //
     // psone
     //
-    D(PackPs1);
+    if (WANT(FT_PS1))
+        D(PackPs1);
 
     //
     // .sys and .com
@@ -218,12 +391,14 @@ Packer *PackMaster::visitAllPackers(visit_func_t func, InputFile *f, const optio
     D(PackCom);
 
     // Mach (macOS)
-    D(PackDylibAMD64);
-    D(PackMachPPC32); // TODO: this works with upx 3.91..3.94 but got broken in 3.95; FIXME
-    D(PackMachI386);
-    D(PackMachAMD64);
-    D(PackMachARMEL);
-    D(PackMachARM64EL);
+    if (WANT(FT_MACH)) {
+        D(PackDylibAMD64);
+        D(PackMachPPC32); // TODO: this works with upx 3.91..3.94 but got broken in 3.95; FIXME
+        D(PackMachI386);
+        D(PackMachAMD64);
+        D(PackMachARMEL);
+        D(PackMachARM64EL);
+    }
 
     // 2010-03-12  omit these because PackMachBase<T>::pack4dylib (p_mach.cpp)
     // does not understand what the Darwin (Apple Mac OS X) dynamic loader
@@ -232,6 +407,8 @@ Packer *PackMaster::visitAllPackers(visit_func_t func, InputFile *f, const optio
     //   D(PackDylibPPC32);
 
     return nullptr;
+#undef WANT_ELF
+#undef WANT
 #undef D
 }
 
@@ -244,7 +421,7 @@ Packer *PackMaster::getPacker(InputFile *f) {
 }
 
 Packer *PackMaster::getUnpacker(InputFile *f) {
-    Packer *pp = visitAllPackers(try_unpack, f, opt, f);
+    Packer *pp = findUnpacker(f);
     if (!pp)
         throwNotPacked();
     pp->assertPacker();
@@ -281,7 +458,7 @@ void PackMaster::list() {
 }
 
 void PackMaster::fileInfo() {
-    p = visitAllPackers(try_unpack, fi, opt, fi);
+    p = findUnpacker(fi);
     if (!p)
         p = visitAllPackers(try_pack, fi, opt, fi);
     if (!p)
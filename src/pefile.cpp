@@ -227,8 +227,15 @@ int __acc_cdecl_qsort PeFile::Interval::compare(const void *p1, const void *p2)
 }
 
 void PeFile::Interval::add(unsigned start, unsigned len) {
-    if (ivnum == capacity)
-        ivarr = (interval *) realloc(ivarr, (capacity += 15) * sizeof(interval));
+    if (ivnum == capacity) {
+        // grow geometrically: processImports0() adds one interval per import
+        const unsigned new_capacity = capacity ? 2 * capacity : 16;
+        void *p = realloc(ivarr, mem_size(sizeof(interval), new_capacity));
+        if (p == nullptr)
+            throwOutOfMemoryException();
+        ivarr = (interval *) p;
+        capacity = new_capacity;
+    }
     ivarr[ivnum].start = start;
     ivarr[ivnum++].len = len;
 }
@@ -242,16 +249,18 @@ void PeFile::Interval::flatten() {
     if (!ivnum)
         return;
     qsort(ivarr, ivnum, sizeof(interval), Interval::compare);
-    for (unsigned ic = 0; ic < ivnum - 1; ic++) {
-        unsigned jc;
-        for (jc = ic + 1; jc < ivnum && ivarr[ic].start + ivarr[ic].len >= ivarr[jc].start; jc++)
-            if (ivarr[ic].start + ivarr[ic].len < ivarr[jc].start + ivarr[jc].len)
-                ivarr[ic].len = ivarr[jc].start + ivarr[jc].len - ivarr[ic].start;
-        if (jc > ic + 1) {
-            memmove(ivarr + ic + 1, ivarr + jc, sizeof(interval) * (ivnum - jc));
-            ivnum -= jc - ic - 1;
-        }
+    // merge overlapping and adjacent intervals in a single pass
+    unsigned jc = 0;
+    for (unsigned ic = 1; ic < ivnum; ic++) {
+        interval *const last = &ivarr[jc];
+        const interval *const cur = &ivarr[ic];
+        if (last->start + last->len >= cur->start) {
+            if (last->start + last->len < cur->start + cur->len)
+                last->len = cur->start + cur->len - last->start;
+        } else
+            ivarr[++jc] = *cur;
     }
+    ivnum = jc + 1;
 }
 
 void PeFile::Interval::clear() {
@@ -316,7 +325,7 @@ void PeFile::Reloc::add(unsigned pos, unsigned type) {
 void PeFile::Reloc::finish(upx_byte *&p, unsigned &siz) {
     unsigned prev = 0xffffffff;
     set_le32(start + 1024 + 4 * counts[0]++, 0xf0000000);
-    qsort(start + 1024, counts[0], 4, le32_compare);
+    sort_le32(start + 1024, counts[0]);
 
     rel = (reloc *) start;
     rel1 = (LE16 *) start;
@@ -392,7 +401,7 @@ void PeFile32::processRelocs() // pass1
 
     // remove duplicated records
     for (ic = 1; ic <= 3; ic++) {
-        qsort(fix[ic], xcounts[ic], 4, le32_compare);
+        sort_le32(fix[ic], xcounts[ic]);
         unsigned prev = ~0u;
         unsigned jc = 0;
         for (unsigned kc = 0; kc < xcounts[ic]; kc++)
@@ -491,7 +500,7 @@ void PeFile64::processRelocs() // pass1
 
     // remove duplicated records
     for (ic = 1; ic <= 15; ic++) {
-        qsort(fix[ic], xcounts[ic], 4, le32_compare);
+        sort_le32(fix[ic], xcounts[ic]);
         unsigned prev = ~0u;
         unsigned jc = 0;
         for (unsigned kc = 0; kc < xcounts[ic]; kc++)
@@ -1453,7 +1462,8 @@ struct PeFile::Resource::upx_rleaf : public PeFile::Resource::upx_rnode {
     res_data data;
 };
 
-PeFile::Resource::Resource(const upx_byte *ibufstart_, const upx_byte *ibufend_) : root(nullptr) {
+PeFile::Resource::Resource(const upx_byte *ibufstart_, const upx_byte *ibufend_)
+    : nodes_size(0), nodes_used(0), root(nullptr) {
     ibufstart = ibufstart_;
     ibufend = ibufend_;
 }
@@ -1465,12 +1475,7 @@ PeFile::Resource::Resource(const upx_byte *p, const upx_byte *ibufstart_,
     init(p);
 }
 
-PeFile::Resource::~Resource() {
-    if (root) {
-        destroy(root, 0);
-        root = nullptr;
-    }
-}
+PeFile::Resource::~Resource() {}
 
 unsigned PeFile::Resource::dirsize() const { return ALIGN_UP(dsize + ssize, 4u); }
 
@@ -1512,7 +1517,10 @@ void PeFile::Resource::init(const upx_byte *res) {
     start = res;
     root = head = current = nullptr;
     dsize = ssize = 0;
+    nodes_size = nodes_used = 0;
     check((const res_dir *) start, 0);
+    // allocate the whole tree at once; see alloc()
+    mb_nodes.alloc(nodes_size ? nodes_size : 1);
     root = convert(start, nullptr, 0);
 }
 
@@ -1521,15 +1529,34 @@ void PeFile::Resource::check(const res_dir *node, unsigned level) {
     int ic = node->identr + node->namedentr;
     if (ic == 0)
         return;
+    // count the bytes that convert() will take from the arena
+    nodes_size = mem_size(1, nodes_size, ALIGN_UP(unsigned(sizeof(upx_rbranch)), 8u),
+                          ALIGN_UP(unsigned(sizeof(upx_rnode *) * ic), 8u));
     for (const res_dir_entry *rde = node->entries; --ic >= 0; rde++) {
         ibufcheck(rde, sizeof(*rde));
         if (((rde->child & 0x80000000) == 0) ^ (level == 2))
             throwCantPack("unsupported resource structure");
         else if (level != 2)
             check((const res_dir *) (start + (rde->child & 0x7fffffff)), level + 1);
+        else
+            nodes_size = mem_size(1, nodes_size, ALIGN_UP(unsigned(sizeof(upx_rleaf)), 8u));
+        if (rde->tnl & 0x80000000) {
+            const upx_byte *p = start + (rde->tnl & 0x7fffffff);
+            ibufcheck(p, 2);
+            nodes_size = mem_size(1, nodes_size, ALIGN_UP(2u + 2 * get_le16(p), 8u));
+        }
     }
 }
 
+void *PeFile::Resource::alloc(unsigned size) {
+    size = ALIGN_UP(size, 8u);
+    if (size > nodes_size - nodes_used)
+        throwCantUnpack("corrupted resources");
+    void *p = (upx_byte *) mb_nodes.getVoidPtr() + nodes_used;
+    nodes_used += size;
+    return p;
+}
+
 void PeFile::Resource::ibufcheck(const void *m, unsigned siz) {
     if (m < ibufstart || m > ibufend - siz)
         throwCantUnpack("corrupted resources");
@@ -1540,7 +1567,7 @@ PeFile::Resource::upx_rnode *PeFile::Resource::convert(const void *rnode, upx_rn
     if (level == 3) {
         const res_data *node = ACC_STATIC_CAST(const res_data *, rnode);
         ibufcheck(node, sizeof(*node));
-        upx_rleaf *leaf = new upx_rleaf;
+        upx_rleaf *leaf = new (alloc(sizeof(upx_rleaf))) upx_rleaf;
         leaf->id = 0;
         leaf->name = nullptr;
         leaf->parent = parent;
@@ -1559,12 +1586,12 @@ PeFile::Resource::upx_rnode *PeFile::Resource::convert(const void *rnode, upx_rn
     if (ic == 0)
         return nullptr;
 
-    upx_rbranch *branch = new upx_rbranch;
+    upx_rbranch *branch = new (alloc(sizeof(upx_rbranch))) upx_rbranch;
     branch->id = 0;
     branch->name = nullptr;
     branch->parent = parent;
     branch->nc = ic;
-    branch->children = New(upx_rnode *, ic);
+    branch->children = (upx_rnode **) alloc(sizeof(upx_rnode *) * ic);
     branch->data = *node;
 
     for (const res_dir_entry *rde = node->entries + ic - 1; --ic >= 0; rde--) {
@@ -1577,7 +1604,7 @@ PeFile::Resource::upx_rnode *PeFile::Resource::convert(const void *rnode, upx_rn
             ibufcheck(p, 2);
             const unsigned len = 2 + 2 * get_le16(p);
             ibufcheck(p, len);
-            child->name = New(upx_byte, len);
+            child->name = (upx_byte *) alloc(len);
             memcpy(child->name, p, len); // copy unicode string
             ssize += len;                // size of unicode strings
         }
@@ -1644,25 +1671,6 @@ upx_byte *PeFile::Resource::build() {
     return newstart;
 }
 
-void PeFile::Resource::destroy(upx_rnode *node, unsigned level) {
-    xcheck(node);
-    if (level == 3) {
-        upx_rleaf *leaf = ACC_STATIC_CAST(upx_rleaf *, node);
-        delete[] leaf->name;
-        leaf->name = nullptr;
-        delete leaf;
-    } else {
-        upx_rbranch *branch = ACC_STATIC_CAST(upx_rbranch *, node);
-        delete[] branch->name;
-        branch->name = nullptr;
-        for (int ic = branch->nc; --ic >= 0;)
-            destroy(branch->children[ic], level + 1);
-        delete[] branch->children;
-        branch->children = nullptr;
-        delete branch;
-    }
-}
-
 static void lame_print_unicode(const upx_byte *p) {
     for (unsigned ic = 0; ic < get_le16(p); ic++)
         printf("%c", (char) p[ic * 2 + 2]);
@@ -374,6 +374,9 @@ protected:
         MemBuffer mb_start;
         const upx_byte *start;
         upx_byte *newstart;
+        MemBuffer mb_nodes; // arena for the upx_rnode tree, sized by check()
+        unsigned nodes_size;
+        unsigned nodes_used;
         upx_rnode *root;
         upx_rleaf *head;
         upx_rleaf *current;
@@ -388,7 +391,7 @@ protected:
         void build(const upx_rnode *, unsigned &, unsigned &, unsigned);
         void clear(upx_byte *, unsigned, Interval *);
         void dump(const upx_rnode *, unsigned) const;
-        void destroy(upx_rnode *urd, unsigned level);
+        void *alloc(unsigned size);
 
         void ibufcheck(const void *m, unsigned size);
 